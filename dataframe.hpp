@@ -7,8 +7,14 @@
  *           append one row from std::vector & remove row
  *           insert one column from std::vector & remove column
  *           get a row of data by index of the row
+ *           iterate over rows & copy them into a row-major buffer
  *           get a column of data by string of the column
  *           concat & add double dataFrame object (horizontally & vertically)
+ *           hash & sorted value index on columns for point and range lookups
+ *           per block min/max statistics of columns for scan skipping
+ *           compress integer columns (run-length, delta, frame-of-reference)
+ *           zero-copy import & export through the arrow C data interface
+ *           export into a dense matrix, covariance & correlation of columns
  *           ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  * @details
  * @author   Flame
@@ -25,97 +31,320 @@
 #include <exception>
 #include <sstream>
 #include <unordered_map>
+#include <type_traits>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+// arrow C data interface, https://arrow.apache.org/docs/format/CDataInterface.html
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+struct ArrowSchema {
+    // array type description
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+
+    // release callback
+    void (*release)(struct ArrowSchema *);
+    // opaque producer-specific data
+    void *private_data;
+};
+
+struct ArrowArray {
+    // array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+
+    // release callback
+    void (*release)(struct ArrowArray *);
+    // opaque producer-specific data
+    void *private_data;
+};
+}
+
+#endif // ARROW_C_DATA_INTERFACE
 
 template<typename T = double>
 class dataframe {
 public:
     class column_array {
-        typedef typename std::vector<T>::const_iterator iter;
-        std::vector<T> *array = nullptr;
+        typedef const T *iter;
+    public:
+        // number of items covered by one zone
+        static const unsigned long long int block_size = 4096;
+
+        // statistics of one block of items, nulls (NaN) are left out of min & max
+        struct zone {
+            T min = T();
+            T max = T();
+            unsigned long long int count = 0;
+            unsigned long long int null_count = 0;
+            bool sorted = true; // ascending and without null, a write may leave it false for a sorted block
+            bool exact = true;  // min & max are reached, otherwise a write left them as wider bounds
+        };
+
+        // reference to one item, a write through it goes through set
+        class item_ref {
+            column_array *array = nullptr;
+            unsigned long long int i = 0;
+        public:
+            item_ref(column_array *_array, unsigned long long int _i) : array(_array), i(_i) {}
+
+            item_ref(const item_ref &item) = default;
+
+            operator T() const {
+                return array->value(i);
+            }
+
+            item_ref &operator=(const T &item) {
+                array->set(i, item);
+                return *this;
+            }
+
+            item_ref &operator=(const item_ref &item) {
+                array->set(i, static_cast<T>(item));
+                return *this;
+            }
+
+            item_ref &operator+=(const T &item) {
+                array->set(i, array->value(i) + item);
+                return *this;
+            }
+
+            item_ref &operator-=(const T &item) {
+                array->set(i, array->value(i) - item);
+                return *this;
+            }
+
+            item_ref &operator*=(const T &item) {
+                array->set(i, array->value(i) * item);
+                return *this;
+            }
+
+            item_ref &operator/=(const T &item) {
+                array->set(i, array->value(i) / item);
+                return *this;
+            }
+
+            friend std::ostream &operator<<(std::ostream &cout, const item_ref &item) {
+                return cout << static_cast<T>(item);
+            }
+        };
+
+        // storage of the items, the compressed ones only hold integer values
+        enum encoding {
+            plain,              // std::vector<T>
+            run_length,         // value & end of each run
+            delta,              // bit-packed difference to the previous item
+            frame_of_reference  // bit-packed difference to the minimum
+        };
+
+    private:
+        // number of delta items decoded from one stored item
+        static const unsigned long long int anchor_size = 128;
+
+        // compressed items
+        struct packed_array {
+            encoding type = plain;
+            unsigned long long int count = 0;
+            unsigned int bits = 0;                     // width of one packed code
+            long long int reference = 0;               // minimum of the values or differences
+            std::vector<unsigned long long int> codes; // bit-packed codes
+            std::vector<long long int> values;         // value of each run, or first item of each anchor
+            std::vector<unsigned long long int> ends;  // end of each run
+        };
+
+        std::shared_ptr<std::vector<T>> array; // shared with the arrays exported to arrow
+        std::shared_ptr<const T> foreign;      // items of an imported buffer, read in place
+        unsigned long long int foreign_size = 0;
+        std::vector<zone> zones;
+        packed_array packed;
+        unsigned long long int version = 0;
     public:
         explicit column_array(int n = 0) {
-            array = new std::vector<T>(n);
+            array = std::make_shared<std::vector<T>>(n);
+            build_zones(0);
         }
 
-        column_array(const column_array &_array) {
-            array = new std::vector<T>(*_array.array);
+        column_array(const column_array &_array) :
+                foreign(_array.foreign),
+                foreign_size(_array.foreign_size),
+                zones(_array.zones),
+                packed(_array.packed),
+                version(_array.version) {
+            array = std::make_shared<std::vector<T>>(*_array.array);
         }
 
-        column_array(column_array &&_array) noexcept {
-            array = new std::vector<T>(std::move(*_array.array));
+        column_array(column_array &&_array) noexcept :
+                array(std::move(_array.array)),
+                foreign(std::move(_array.foreign)),
+                foreign_size(_array.foreign_size),
+                zones(std::move(_array.zones)),
+                packed(std::move(_array.packed)),
+                version(_array.version) {
+            _array.array = std::make_shared<std::vector<T>>();
+            _array.foreign_size = 0;
+            _array.packed = packed_array();
         }
 
         explicit column_array(std::vector<T> &&_array) {
-            array = new std::vector<T>(_array);
+            array = std::make_shared<std::vector<T>>(std::move(_array));
+            build_zones(0);
         }
 
         explicit column_array(const std::vector<T> &_array) {
-            array = new std::vector<T>(_array);
+            array = std::make_shared<std::vector<T>>(_array);
+            build_zones(0);
         }
 
-        ~column_array() {
-            delete array;
+        // wrap n items owned by someone else, they are copied by the first write
+        column_array(std::shared_ptr<const T> items, unsigned long long int n) :
+                foreign(std::move(items)),
+                foreign_size(n) {
+            array = std::make_shared<std::vector<T>>();
+            build_zones(0);
         }
 
         void insert(iter position, iter start, iter end) {
-            array->insert(position, start, end);
+            auto offset = static_cast<unsigned long long int>(position - begin());
+            std::vector<T> &items = writable();
+            auto last = items.size();
+            items.insert(items.begin() + offset, start, end);
+            if (offset == last) {
+                for (auto i = last; i < items.size(); ++i) {
+                    extend_zone(i);
+                }
+            } else {
+                build_zones(offset);
+                ++version;
+            }
         }
 
         [[nodiscard]] unsigned long long int size() const {
             if (array == nullptr)
                 return 0;
+            if (packed.type != plain)
+                return packed.count;
+            if (foreign)
+                return foreign_size;
             return array->size();
         }
 
         [[nodiscard]] iter begin() const {
-            return array->begin();
+            return data();
         }
 
         [[nodiscard]] iter end() const {
-            return array->end();
+            return data() + size();
+        }
+
+        [[nodiscard]] iter begin() {
+            return data();
+        }
+
+        [[nodiscard]] iter end() {
+            return data() + size();
         }
 
         void erase(iter i) {
-            array->erase(i);
+            auto offset = static_cast<unsigned long long int>(i - begin());
+            std::vector<T> &items = writable();
+            items.erase(items.begin() + offset);
+            build_zones(offset);
+            ++version;
         }
 
         void emplace_back(const T &item) {
-            array->emplace_back(item);
+            writable().emplace_back(item);
+            extend_zone(array->size() - 1);
         }
 
         column_array &operator=(const column_array &_array) {
-            if (_array.size() == array->size()) {
-                array->clear();
-                array->insert(array->begin(), _array.begin(), _array.end());
+            if (_array.size() == size()) {
+                std::vector<T> &items = writable();
+                items.clear();
+                items.insert(items.begin(), _array.begin(), _array.end());
+                build_zones(0);
+                ++version;
                 return *this;
             }
             throw (std::invalid_argument("The length of the two is not the same"));
         }
 
         column_array &operator=(const std::vector<T> &_array) {
-            if (_array.size() == array->size()) {
-                array->clear();
-                array->insert(array->begin(), _array.begin(), _array.end());
+            if (_array.size() == size()) {
+                std::vector<T> &items = writable();
+                items.clear();
+                items.insert(items.begin(), _array.begin(), _array.end());
+                build_zones(0);
+                ++version;
                 return *this;
             }
             throw (std::invalid_argument("The length of the two is not the same"));
         }
 
         column_array &operator=(std::vector<T> &&_array) {
-            if (_array.size() == array->size()) {
-                *array = _array;
+            if (_array.size() == size()) {
+                writable() = std::move(_array);
+                build_zones(0);
+                ++version;
                 return *this;
             }
             throw (std::invalid_argument("The length of the two is not the same"));
         }
 
-        const std::vector<T> & get_std_vector(){
-            return *array;
+        const std::vector<T> & get_std_vector() {
+            return unpacked();
         }
 
-        const T &operator[](unsigned long long int i) const {
-            if (i < array->size())
-                return (*array)[i];
+        // get the items in place, only a compressed column is decompressed first
+        const T *data() {
+            if (foreign)
+                return foreign.get();
+            return unpacked().data();
+        }
+
+        // get the items in place, a compressed column is never decompressed by a const read
+        const T *data() const {
+            if (packed.type != plain)
+                throw (std::logic_error("the column is compressed, read it by value or decode!"));
+            if (foreign)
+                return foreign.get();
+            return array->data();
+        }
+
+        // get a copy of the ith item, a compressed column stays compressed
+        T operator[](unsigned long long int i) const {
+            return value(i);
+        }
+
+        item_ref operator[](unsigned long long int i) {
+            if (i < size())
+                return item_ref(this, i);
             else {
                 std::stringstream ssTemp;
                 ssTemp << i;
@@ -123,107 +352,590 @@ public:
             }
         }
 
-        T &operator[](unsigned long long int i) {
-            if (i < array->size())
-                return (*array)[i];
-            else {
+        // write the ith item, the zone of its block stays a bound of its items
+        void set(unsigned long long int i, const T &item) {
+            if (i >= size()) {
+                std::stringstream ssTemp;
+                ssTemp << i;
+                throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+            }
+            std::vector<T> &items = writable();
+            T last = items[i];
+            items[i] = item;
+            zone &block = zones[i / block_size];
+            if (is_null(last))
+                --block.null_count;
+            else if (!(last == item) && !(block.min < last && last < block.max))
+                block.exact = false;
+            if (is_null(item)) {
+                ++block.null_count;
+                block.sorted = false;
+            } else if (block.null_count + 1 == block.count) {
+                block.min = block.max = item;
+                block.exact = true;
+            } else {
+                if (item < block.min)
+                    block.min = item;
+                if (block.max < item)
+                    block.max = item;
+            }
+            auto first = i - i % block_size;
+            if ((i > first && item < items[i - 1]) || (i + 1 < first + block.count && items[i + 1] < item))
+                block.sorted = false;
+            ++version;
+        }
+
+        // count of the writes other than appends, the items kept their rows while it is unchanged
+        [[nodiscard]] unsigned long long int get_version() const {
+            return version;
+        }
+
+        // get a copy of the ith item, compressed items are decoded without decompressing the column
+        T value(unsigned long long int i) const {
+            if (i >= size()) {
                 std::stringstream ssTemp;
                 ssTemp << i;
                 throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
             }
+            if (packed.type == plain)
+                return data()[i];
+            if (packed.type == run_length) {
+                auto run = std::upper_bound(packed.ends.begin(), packed.ends.end(), i) - packed.ends.begin();
+                return from_integer(packed.values[run]);
+            }
+            unsigned long long int item = 0;
+            for (auto j = packed.type == delta ? i - i % anchor_size : i; j <= i; ++j) {
+                item = next_value(j, item);
+            }
+            return from_integer(static_cast<long long int>(item));
+        }
+
+        // get the statistics of all blocks
+        const std::vector<zone> &zone_map() const {
+            return zones;
+        }
+
+        // determine whether the whole column is ascending and without null
+        bool sorted() const {
+            const std::vector<zone> &map = zone_map();
+            for (unsigned long long int b = 0; b < map.size(); ++b) {
+                if (!map[b].sorted || (b > 0 && map[b].min < map[b - 1].max))
+                    return false;
+            }
+            return true;
+        }
+
+        // NaN is the only null value of a column
+        static bool is_null(const T &item) {
+            return !(item == item);
+        }
+
+        // get the encoding of the items
+        encoding get_encoding() const {
+            return packed.type;
+        }
+
+        // compress the items with the smallest encoding, it keeps plain if none of them is smaller
+        encoding compress() {
+            if (packed.type != plain || size() == 0)
+                return packed.type;
+            const T *items = data();
+            long long int item = 0, previous = 0;
+            unsigned long long int runs = 0, low = 0, high = 0;
+            for (unsigned long long int i = 0; i < size(); ++i) {
+                if (!to_integer(items[i], item))
+                    return plain;
+                if (i == 0 || item != previous)
+                    ++runs;
+                if (i > 0) {
+                    // differences wrap around like the decoder does
+                    auto difference = static_cast<long long int>(static_cast<unsigned long long int>(item) -
+                                                                 static_cast<unsigned long long int>(previous));
+                    if (i == 1 || difference < static_cast<long long int>(low))
+                        low = static_cast<unsigned long long int>(difference);
+                    if (i == 1 || difference > static_cast<long long int>(high))
+                        high = static_cast<unsigned long long int>(difference);
+                }
+                previous = item;
+            }
+            long long int min_item = 0, max_item = 0;
+            to_integer(min(), min_item);
+            to_integer(max(), max_item);
+            // estimated bytes of every encoding
+            unsigned long long int n = size();
+            unsigned long long int plain_bytes = n * sizeof(T);
+            unsigned long long int run_length_bytes = runs * 16;
+            unsigned long long int delta_bytes = (n * bit_width(high - low) + 63) / 64 * 8 +
+                                                 (n + anchor_size - 1) / anchor_size * 8;
+            auto spread = static_cast<unsigned long long int>(max_item) - static_cast<unsigned long long int>(min_item);
+            unsigned long long int reference_bytes = (n * bit_width(spread) + 63) / 64 * 8;
+            auto best = std::min(std::min(run_length_bytes, delta_bytes), reference_bytes);
+            if (best >= plain_bytes)
+                return plain;
+            compress(best == reference_bytes ? frame_of_reference : best == run_length_bytes ? run_length : delta);
+            return packed.type;
+        }
+
+        // compress the items with the given encoding, fails when they are not all integers
+        bool compress(encoding type) {
+            if (type == plain) {
+                unpacked();
+                return true;
+            }
+            const T *items = data();
+            std::vector<long long int> values(size());
+            for (unsigned long long int i = 0; i < values.size(); ++i) {
+                if (!to_integer(items[i], values[i]))
+                    return false;
+            }
+            build_zones(0);
+            packed = packed_array();
+            packed.type = type;
+            packed.count = values.size();
+            if (type == run_length) {
+                for (unsigned long long int i = 0; i < values.size(); ++i) {
+                    if (i == 0 || values[i] != values[i - 1]) {
+                        packed.values.emplace_back(values[i]);
+                        packed.ends.emplace_back(i + 1);
+                    } else ++packed.ends.back();
+                }
+            } else {
+                std::vector<unsigned long long int> codes(values.size());
+                for (unsigned long long int i = 0; i < values.size(); ++i) {
+                    codes[i] = static_cast<unsigned long long int>(values[i]);
+                    if (type == delta) {
+                        if (i % anchor_size == 0)
+                            packed.values.emplace_back(values[i]);
+                        codes[i] -= i == 0 ? codes[i] : static_cast<unsigned long long int>(values[i - 1]);
+                    }
+                }
+                // the codes at anchors of delta are not used, they borrow the first difference
+                if (type == delta && codes.size() > 1) {
+                    for (unsigned long long int i = 0; i < codes.size(); i += anchor_size) {
+                        codes[i] = codes[1];
+                    }
+                }
+                packed.reference = static_cast<long long int>(*std::min_element(
+                        codes.begin(), codes.end(),
+                        [](unsigned long long int a, unsigned long long int b) {
+                            return static_cast<long long int>(a) < static_cast<long long int>(b);
+                        }));
+                unsigned long long int range = 0;
+                for (auto &code : codes) {
+                    code -= static_cast<unsigned long long int>(packed.reference);
+                    range = std::max(range, code);
+                }
+                packed.bits = bit_width(range);
+                packed.codes.assign((codes.size() * packed.bits + 63) / 64, 0);
+                for (unsigned long long int i = 0; i < codes.size(); ++i) {
+                    put_code(i, codes[i]);
+                }
+            }
+            // drop the plain items, arrays exported to arrow keep their own reference
+            array = std::make_shared<std::vector<T>>();
+            foreign.reset();
+            foreign_size = 0;
+            return true;
+        }
+
+        // sum of all items
+        T sum() const {
+            T total = T();
+            if (packed.type == plain) {
+                const T *items = data();
+                for (unsigned long long int i = 0; i < size(); ++i) {
+                    total += items[i];
+                }
+                return total;
+            }
+            for_each_run([&total](unsigned long long int first, unsigned long long int last, long long int item) {
+                total += from_integer(item) * from_integer(static_cast<long long int>(last - first));
+            });
+            return total;
+        }
+
+        // minimum of all items except nulls, T() when there is none
+        T min() const {
+            bool found = false;
+            T item = T();
+            for (unsigned long long int b = 0; b < zones.size(); ++b) {
+                const zone &block = zones[b].exact ? zones[b] : compute_zone(b);
+                if (block.null_count < block.count && (!found || block.min < item)) {
+                    item = block.min;
+                    found = true;
+                }
+            }
+            return item;
+        }
+
+        // maximum of all items except nulls, T() when there is none
+        T max() const {
+            bool found = false;
+            T item = T();
+            for (unsigned long long int b = 0; b < zones.size(); ++b) {
+                const zone &block = zones[b].exact ? zones[b] : compute_zone(b);
+                if (block.null_count < block.count && (!found || item < block.max)) {
+                    item = block.max;
+                    found = true;
+                }
+            }
+            return item;
+        }
+
+        // number of items equal to the item
+        unsigned long long int count(const T &item) const {
+            unsigned long long int total = 0;
+            if (packed.type == plain) {
+                const T *items = data();
+                for (unsigned long long int i = 0; i < size(); ++i) {
+                    if (items[i] == item)
+                        ++total;
+                }
+                return total;
+            }
+            for_each_run([&](unsigned long long int first, unsigned long long int last, long long int value) {
+                if (from_integer(value) == item)
+                    total += last - first;
+            });
+            return total;
+        }
+
+        // get the items in [low, high] in ascending order, skipping blocks by their zone, null bounds match none
+        /* Note: a compressed column stays compressed, only the blocks that may hold matches are decoded */
+        std::vector<unsigned long long int> find(const T &low, const T &high) const {
+            std::vector<unsigned long long int> rows;
+            if (is_null(low) || is_null(high))
+                return rows;
+            if (sorted()) {
+                auto first = bound(low, false);
+                auto last = std::max(first, bound(high, true));
+                for (auto i = first; i < last; ++i) {
+                    rows.emplace_back(i);
+                }
+                return rows;
+            }
+            std::vector<T> buffer;
+            for (unsigned long long int b = 0; b < zones.size(); ++b) {
+                const zone &block = zones[b];
+                if (block.null_count == block.count || high < block.min || block.max < low)
+                    continue;
+                auto first = b * block_size;
+                if (block.null_count == 0 && !(block.min < low) && !(high < block.max)) {
+                    for (auto i = first; i < first + block.count; ++i) {
+                        rows.emplace_back(i);
+                    }
+                    continue;
+                }
+                const T *items = read(first, block.count, buffer);
+                for (unsigned long long int j = 0; j < block.count; ++j) {
+                    if (!(items[j] < low) && !(high < items[j]) && !is_null(items[j]))
+                        rows.emplace_back(first + j);
+                }
+            }
+            return rows;
+        }
+
+        // get count items from the first one in place, or decoded into the buffer when the column is compressed
+        const T *read(unsigned long long int first, unsigned long long int count, std::vector<T> &buffer) const {
+            if (packed.type == plain && first + count <= size())
+                return data() + first;
+            buffer.resize(count);
+            decode(first, count, buffer.data());
+            return buffer.data();
+        }
+
+        // copy count items from the first one into out, a compressed column stays compressed
+        void decode(unsigned long long int first, unsigned long long int count, T *out) const {
+            if (first + count > size()) {
+                std::stringstream ssTemp;
+                ssTemp << first + count;
+                throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+            }
+            auto last = first + count;
+            if (packed.type == plain) {
+                std::copy(data() + first, data() + last, out);
+            } else if (packed.type == run_length) {
+                auto run = std::upper_bound(packed.ends.begin(), packed.ends.end(), first) - packed.ends.begin();
+                for (auto i = first; i < last; ++i) {
+                    while (packed.ends[run] <= i)
+                        ++run;
+                    out[i - first] = from_integer(packed.values[run]);
+                }
+            } else {
+                unsigned long long int item = 0;
+                for (auto i = packed.type == delta ? first - first % anchor_size : first; i < last; ++i) {
+                    item = next_value(i, item);
+                    if (i >= first)
+                        out[i - first] = from_integer(static_cast<long long int>(item));
+                }
+            }
+        }
+
+        // memory held by the items, in bytes
+        unsigned long long int memory_usage() const {
+            return array->capacity() * sizeof(T) + foreign_size * sizeof(T) + zones.capacity() * sizeof(zone) +
+                   packed.codes.capacity() * sizeof(unsigned long long int) +
+                   packed.values.capacity() * sizeof(long long int) +
+                   packed.ends.capacity() * sizeof(unsigned long long int);
         }
 
-        friend std::ostream &operator<<(std::ostream &cout, column_array &arr) {
-            for (const auto &item : *arr.array) {
-                cout << item << ' ';
+        friend std::ostream &operator<<(std::ostream &cout, const column_array &arr) {
+            std::vector<T> items;
+            unsigned long long int step = block_size;
+            for (unsigned long long int first = 0; first < arr.size(); first += step) {
+                items.resize(std::min(step, arr.size() - first));
+                arr.decode(first, items.size(), items.data());
+                for (const auto &item : items) {
+                    cout << item << ' ';
+                }
             }
             return cout;
         }
-    };
 
-    class row_array {
-        typedef typename std::vector<T *>::const_iterator iter;
-        std::vector<T *> *array = nullptr;
-    public:
-        explicit row_array(int n = 0) {
-            array = new std::vector<T *>(n);
+        // share the items with their owner, for buffers exported to arrow
+        /* Note: a compressed column stays compressed, its items are decoded into a buffer owned by the caller */
+        std::shared_ptr<const T> share() const {
+            if (foreign)
+                return foreign;
+            if (packed.type != plain) {
+                auto items = std::make_shared<std::vector<T>>(size());
+                decode(0, items->size(), items->data());
+                return std::shared_ptr<const T>(items, items->data());
+            }
+            return std::shared_ptr<const T>(array, array->data());
         }
 
-        row_array(const row_array &_array) {
-            array = new std::vector<T *>(*_array.array);
+    private:
+        // get the plain items, a compressed or imported column is copied into its own vector first
+        std::vector<T> &unpacked() {
+            if (foreign) {
+                array = std::make_shared<std::vector<T>>(foreign.get(), foreign.get() + foreign_size);
+                foreign.reset();
+                foreign_size = 0;
+            }
+            if (packed.type != plain) {
+                array->resize(packed.count);
+                for_each_run([this](unsigned long long int first, unsigned long long int last, long long int item) {
+                    std::fill(array->begin() + first, array->begin() + last, from_integer(item));
+                });
+                packed = packed_array();
+            }
+            return *array;
         }
 
-        row_array(row_array &&_array) noexcept {
-            array = new std::vector<T *>(std::move(*_array.array));
+        // get the plain items for writing, a vector shared with arrow is copied first
+        std::vector<T> &writable() {
+            unpacked();
+            if (array.use_count() > 1)
+                array = std::make_shared<std::vector<T>>(*array);
+            return *array;
         }
 
-        explicit row_array(std::vector<T *> &&_array) {
-            array = new std::vector<T *>(_array);
+        // first row whose item is greater than the item when upper, otherwise not less than it, on a sorted column
+        unsigned long long int bound(const T &item, bool upper) const {
+            unsigned long long int first = 0;
+            unsigned long long int count = size();
+            while (count > 0) {
+                auto step = count / 2;
+                T middle = value(first + step);
+                if (upper ? !(item < middle) : middle < item) {
+                    first += step + 1;
+                    count -= step + 1;
+                } else count = step;
+            }
+            return first;
         }
 
-        explicit row_array(const std::vector<T *> &_array) {
-            array = new std::vector<T *>(_array);
+        // call f(first, last, value) for every run of equal compressed items
+        template<typename F>
+        void for_each_run(F f) const {
+            if (packed.type == run_length) {
+                unsigned long long int first = 0;
+                for (unsigned long long int r = 0; r < packed.values.size(); ++r) {
+                    f(first, packed.ends[r], packed.values[r]);
+                    first = packed.ends[r];
+                }
+                return;
+            }
+            unsigned long long int item = 0;
+            for (unsigned long long int i = 0; i < packed.count; ++i) {
+                item = next_value(i, item);
+                f(i, i + 1, static_cast<long long int>(item));
+            }
         }
 
-        ~row_array() {
-            delete array;
+        // decode the ith bit-packed item from the item before it
+        unsigned long long int next_value(unsigned long long int i, unsigned long long int previous) const {
+            unsigned long long int item = static_cast<unsigned long long int>(packed.reference) + get_code(i);
+            if (packed.type == frame_of_reference)
+                return item;
+            if (i % anchor_size == 0)
+                return static_cast<unsigned long long int>(packed.values[i / anchor_size]);
+            return previous + item;
         }
 
-        void insert(iter position, iter start, iter end) {
-            array->insert(position, start, end);
+        // write the ith code of packed.bits width
+        void put_code(unsigned long long int i, unsigned long long int code) {
+            if (packed.bits == 0)
+                return;
+            auto bit = i * packed.bits;
+            auto shift = bit % 64;
+            packed.codes[bit / 64] |= code << shift;
+            if (shift + packed.bits > 64)
+                packed.codes[bit / 64 + 1] |= code >> (64 - shift);
         }
 
-        [[nodiscard]] unsigned long long int size() const {
-            if (array == nullptr)
+        // read the ith code of packed.bits width
+        unsigned long long int get_code(unsigned long long int i) const {
+            if (packed.bits == 0)
                 return 0;
-            return array->size();
+            auto bit = i * packed.bits;
+            auto shift = bit % 64;
+            unsigned long long int code = packed.codes[bit / 64] >> shift;
+            if (shift + packed.bits > 64)
+                code |= packed.codes[bit / 64 + 1] << (64 - shift);
+            return packed.bits == 64 ? code : code & ((1ULL << packed.bits) - 1);
         }
 
-        [[nodiscard]] iter begin() const {
-            return array->begin();
+        // number of bits to hold the value
+        static unsigned int bit_width(unsigned long long int value) {
+            unsigned int bits = 0;
+            for (; value != 0; value >>= 1) {
+                ++bits;
+            }
+            return bits;
         }
 
-        [[nodiscard]] iter end() const {
-            return array->end();
+        // convert the item into an integer, fails when it does not keep the value
+        static bool to_integer(const T &item, long long int &value) {
+            return to_integer(item, value, std::is_arithmetic<T>());
         }
 
-        row_array &operator=(const row_array &_array) {
-            if (_array.size() == array->size()) {
-                for (int i = 0; i < _array.size(); ++i) {
-                    *(*array)[i] = _array[i];
-                }
-                return *this;
+        static bool to_integer(const T &item, long long int &value, std::true_type) {
+            auto wide = static_cast<long double>(item);
+            if (!(wide >= -9223372036854775808.0L && wide < 9223372036854775808.0L))
+                return false;
+            // -0.0 equals 0 but would read back as 0
+            if (wide == 0 && std::signbit(wide))
+                return false;
+            value = static_cast<long long int>(item);
+            return static_cast<T>(value) == item;
+        }
+
+        static bool to_integer(const T &, long long int &, std::false_type) {
+            return false;
+        }
+
+        // convert an integer back into an item
+        static T from_integer(long long int value) {
+            return from_integer(value, std::is_arithmetic<T>());
+        }
+
+        static T from_integer(long long int value, std::true_type) {
+            return static_cast<T>(value);
+        }
+
+        static T from_integer(long long int, std::false_type) {
+            return T();
+        }
+
+        // compute the statistics of one block from its items
+        zone compute_zone(unsigned long long int b) const {
+            const T *items = data();
+            zone block;
+            auto last = std::min<unsigned long long int>(size(), (b + 1) * block_size);
+            for (auto i = b * block_size; i < last; ++i) {
+                add_to_zone(block, items, i);
             }
-            throw (std::invalid_argument("The length of the two is not the same"));
+            return block;
+        }
+
+        // recompute the statistics of the blocks from the ith item to the end
+        void build_zones(unsigned long long int i) {
+            zones.resize((size() + block_size - 1) / block_size);
+            for (auto b = i / block_size; b < zones.size(); ++b) {
+                zones[b] = compute_zone(b);
+            }
+        }
+
+        // add the ith item into the statistics of its block
+        static void add_to_zone(zone &block, const T *items, unsigned long long int i) {
+            const T &item = items[i];
+            ++block.count;
+            if (is_null(item)) {
+                ++block.null_count;
+                block.sorted = false;
+                return;
+            }
+            if (block.count == block.null_count + 1) {
+                block.min = block.max = item;
+            } else {
+                if (item < block.min)
+                    block.min = item;
+                if (block.max < item)
+                    block.max = item;
+            }
+            if (block.count > 1 && item < items[i - 1])
+                block.sorted = false;
+        }
+
+        // update the statistics after the ith item is appended
+        void extend_zone(unsigned long long int i) {
+            auto b = i / block_size;
+            if (b == zones.size())
+                zones.emplace_back();
+            add_to_zone(zones[b], array->data(), i);
+        }
+    };
+
+    // one row of a dataframe, a frame pointer and a row number instead of a copy of the items
+    template<typename Frame>
+    class basic_row_ref {
+        typedef typename std::conditional<std::is_const<Frame>::value, const column_array, column_array>::type
+                column_type;
+        typedef typename std::conditional<std::is_const<Frame>::value, T, typename column_array::item_ref>::type
+                reference;
+        Frame *frame = nullptr;
+        unsigned long long int line = 0;
+    public:
+        basic_row_ref(Frame *_frame, unsigned long long int _line) : frame(_frame), line(_line) {}
+
+        basic_row_ref(const basic_row_ref &_row) = default;
+
+        [[nodiscard]] unsigned long long int size() const {
+            return frame->width;
+        }
+
+        // index of the row in the dataframe
+        [[nodiscard]] unsigned long long int row() const {
+            return line;
         }
 
-        row_array &operator=(const std::vector<T> &_array) {
-            if (_array.size() == array->size()) {
-                for (int i = 0; i < _array.size(); ++i) {
-                    *(*array)[i] = _array[i];
+        basic_row_ref &operator=(const basic_row_ref &_row) {
+            if (_row.size() == size()) {
+                for (unsigned long long int i = 0; i < _row.size(); ++i) {
+                    (*this)[i] = _row[i];
                 }
                 return *this;
             }
             throw (std::invalid_argument("The length of the two is not the same"));
         }
 
-        row_array &operator=(std::vector<T> &&_array) {
-            if (_array.size() == array->size()) {
-                for (int i = 0; i < _array.size(); ++i) {
-                    *(*array)[i] = _array[i];
+        basic_row_ref &operator=(const std::vector<T> &_array) {
+            if (_array.size() == size()) {
+                for (unsigned long long int i = 0; i < _array.size(); ++i) {
+                    (*this)[i] = _array[i];
                 }
                 return *this;
             }
             throw (std::invalid_argument("The length of the two is not the same"));
         }
 
-        void push_back(T *item) {
-            array->emplace_back(item);
-        }
-
-        const T &operator[](unsigned long long int i) const {
-            if (i < array->size())
-                return *((*array)[i]);
+        reference operator[](unsigned long long int i) const {
+            if (i < size()) {
+                column_type &array = *frame->matrix[i];
+                return array[line];
+            }
             else {
                 std::stringstream ssTemp;
                 ssTemp << i;
@@ -231,9 +943,10 @@ public:
             }
         }
 
-        T &operator[](unsigned long long int i) {
-            if (i < array->size())
-                return *((*array)[i]);
+        // get a copy of the ith item, a compressed column stays compressed
+        T value(unsigned long long int i) const {
+            if (i < size())
+                return frame->matrix[i]->value(line);
             else {
                 std::stringstream ssTemp;
                 ssTemp << i;
@@ -241,16 +954,142 @@ public:
             }
         }
 
-        friend std::ostream &operator<<(std::ostream &cout, row_array &arr) {
-            for (const auto &item : *arr.array) {
-                cout << item << ' ';
+        // forward iterator over the items of the row, in column order
+        class item_iterator {
+            basic_row_ref row;
+            unsigned long long int i = 0;
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef T value_type;
+            typedef long long int difference_type;
+            typedef void pointer;
+            typedef basic_row_ref::reference reference;
+
+            item_iterator(const basic_row_ref &_row, unsigned long long int _i) : row(_row), i(_i) {}
+
+            reference operator*() const {
+                return row[i];
+            }
+
+            item_iterator &operator++() {
+                ++i;
+                return *this;
+            }
+
+            item_iterator operator++(int) {
+                item_iterator last = *this;
+                ++i;
+                return last;
+            }
+
+            bool operator==(const item_iterator &iter) const {
+                return row.frame == iter.row.frame && row.line == iter.row.line && i == iter.i;
+            }
+
+            bool operator!=(const item_iterator &iter) const {
+                return !(*this == iter);
+            }
+        };
+
+        [[nodiscard]] item_iterator begin() const {
+            return item_iterator(*this, 0);
+        }
+
+        [[nodiscard]] item_iterator end() const {
+            return item_iterator(*this, size());
+        }
+
+        friend std::ostream &operator<<(std::ostream &cout, const basic_row_ref &row) {
+            for (unsigned long long int i = 0; i < row.size(); ++i) {
+                cout << row.value(i) << ' ';
             }
             return cout;
         }
     };
 
+    typedef basic_row_ref<dataframe> row_ref;
+    typedef basic_row_ref<const dataframe> const_row_ref;
+    // the former name of row_ref
+    /* Note: row_ref is a view rather than a copy of the row. Its items are item_ref proxies, so loops such as
+    for (auto &x : df[0]) have to become for (auto &&x : df[0]), or for (T x : df[0]) to only read */
+    typedef row_ref row_array;
+
+    // forward iterator over the rows of a dataframe
+    template<typename Frame>
+    class basic_row_iterator {
+        Frame *frame = nullptr;
+        unsigned long long int line = 0;
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef basic_row_ref<Frame> value_type;
+        typedef long long int difference_type;
+        typedef void pointer;
+        typedef basic_row_ref<Frame> reference;
+
+        basic_row_iterator(Frame *_frame, unsigned long long int _line) : frame(_frame), line(_line) {}
+
+        reference operator*() const {
+            return reference(frame, line);
+        }
+
+        basic_row_iterator &operator++() {
+            ++line;
+            return *this;
+        }
+
+        basic_row_iterator operator++(int) {
+            basic_row_iterator last = *this;
+            ++line;
+            return last;
+        }
+
+        bool operator==(const basic_row_iterator &iter) const {
+            return frame == iter.frame && line == iter.line;
+        }
+
+        bool operator!=(const basic_row_iterator &iter) const {
+            return !(*this == iter);
+        }
+    };
+
+    // all rows of a dataframe, for range-based for loops
+    template<typename Frame>
+    class basic_row_range {
+        Frame *frame = nullptr;
+    public:
+        explicit basic_row_range(Frame *_frame) : frame(_frame) {}
+
+        [[nodiscard]] basic_row_iterator<Frame> begin() const {
+            return basic_row_iterator<Frame>(frame, 0);
+        }
+
+        [[nodiscard]] basic_row_iterator<Frame> end() const {
+            return basic_row_iterator<Frame>(frame, frame->length);
+        }
+
+        [[nodiscard]] unsigned long long int size() const {
+            return frame->length;
+        }
+    };
+
+    typedef basic_row_range<dataframe> row_range;
+    typedef basic_row_range<const dataframe> const_row_range;
+
+    // kind of the secondary value index of a column
+    enum index_type {
+        hash,   // point lookups only
+        sorted  // point and range lookups
+    };
+
+    // layout of a dense matrix
+    enum matrix_layout {
+        row_major,   // items of one row are adjacent
+        column_major // items of one column are adjacent
+    };
+
 private:
     typedef std::vector<std::string> string_vector;
+    typedef std::vector<unsigned long long int> row_vector;
 
 public:
     // constructed by file name
@@ -276,7 +1115,8 @@ public:
             width(dataframe.width),
             length(dataframe.length),
             column(dataframe.column),
-            index(dataframe.index) {
+            index(dataframe.index),
+            value_index(dataframe.copy_index()) {
         matrix.clear();
         for (auto i = dataframe.matrix.begin(); i < dataframe.matrix.end(); ++i) {
             matrix.emplace_back(new column_array(**i));
@@ -288,7 +1128,8 @@ public:
             width(dataframe.width),
             length(dataframe.length),
             column(std::move(dataframe.column)),
-            index(std::move(dataframe.index)) {
+            index(std::move(dataframe.index)),
+            value_index(std::move(dataframe.value_index)) {
         matrix.clear();
         for (auto i = dataframe.matrix.begin(); i < dataframe.matrix.end(); ++i) {
             matrix.emplace_back(new column_array(std::move(**i)));
@@ -400,6 +1241,7 @@ public:
                     index_item.second--;
                 }
             }
+            value_index.erase(col);
             index.erase(item);
             return true;
         }
@@ -420,13 +1262,9 @@ public:
     }
 
     //get one row data from index of row
-    row_array operator[](int i) {
+    row_ref operator[](int i) {
         if (i < length) {
-            row_array row_array;
-            for (auto &item : matrix) {
-                row_array.push_back(&((*item)[i]));
-            }
-            return std::move(row_array);
+            return row_ref(this, i);
         } else {
             std::stringstream ssTemp;
             ssTemp << i;
@@ -435,13 +1273,9 @@ public:
     }
 
     //get one row data from index of row
-    const row_array &operator[](int i) const {
+    const_row_ref operator[](int i) const {
         if (i < length) {
-            row_array row_array;
-            for (auto &item : matrix) {
-                row_array.push_back(&((*item)[i]));
-            }
-            return std::move(row_array);
+            return const_row_ref(this, i);
         } else {
             std::stringstream ssTemp;
             ssTemp << i;
@@ -459,14 +1293,9 @@ public:
         return *(matrix.back());
     }
 
-    //get one column data from column str
+    //get one column data from column str, a missing column is not inserted but thrown
     const column_array &operator[](const std::string &col) const {
-        auto item = index.find(col);
-        if (item != index.end()) {
-            return *(matrix[item->second]);
-        }
-        insert(col);
-        return *(matrix.back());
+        return find_column(col);
     }
 
     //append one row from std::vector<T>
@@ -501,11 +1330,20 @@ public:
 
     //concat double dataframe object vertically
     bool concat_line(const dataframe &dataframe) {
+        // the items of the frame itself would move while they are inserted
+        if (&dataframe == this) {
+            auto rows = dataframe;
+            return concat_line(rows);
+        }
         if (dataframe.width == width) {
-            length += dataframe.length;
+            unsigned long long int rows = dataframe.length;
+            std::vector<T> items;
             for (int i = 0; i < width; ++i) {
-                matrix[i]->insert(matrix[i]->end(), dataframe.get_column(i).begin(), dataframe.get_column(i).end());
+                // a compressed source is decoded into a copy and stays compressed
+                const T *source = dataframe.get_column(i).read(0, rows, items);
+                matrix[i]->insert(matrix[i]->end(), source, source + rows);
             }
+            length += rows;
             return true;
         } else return false;
     }
@@ -565,6 +1403,7 @@ public:
         length = dataframe.length;
         column = std::move(dataframe.column);
         index = std::move(dataframe.index);
+        value_index = std::move(dataframe.value_index);
         matrix.clear();
         for (auto i = dataframe.matrix.begin(); i < dataframe.matrix.end(); ++i) {
             matrix.emplace_back(new column_array(std::move(**i)));
@@ -579,6 +1418,7 @@ public:
         length = dataframe.length;
         column = dataframe.column;
         index = dataframe.index;
+        value_index = dataframe.copy_index();
         matrix.clear();
         for (auto i = dataframe.matrix.begin(); i < dataframe.matrix.end(); ++i) {
             matrix.emplace_back(new column_array(**i));
@@ -619,12 +1459,7 @@ public:
             cout << *item << delimiter;
         }
         cout << column.back() << '\n';
-        for (int i = 0; i < row_num(); ++i) {
-            for (auto array = matrix.begin(); array < matrix.end() - 1; ++array) {
-                cout << (**array)[i] << delimiter;
-            }
-            cout << (*matrix.back())[i] << '\n';
-        }
+        write_rows(cout, delimiter, false);
         cout.close();
     }
 
@@ -636,12 +1471,7 @@ public:
             cout << dataframe.column[j] << "\t";
         }
         cout << '\n';
-        for (int i = 0; i < dataframe.length; ++i) {
-            for (int j = 0; j < dataframe.width; ++j) {
-                cout << (*dataframe.matrix[j])[i] << "\t";
-            }
-            cout << '\n';
-        }
+        dataframe.write_rows(cout, '\t', true);
         return cout;
     }
 
@@ -650,7 +1480,550 @@ public:
         return column;
     }
 
+    // iterate over all rows without copying them
+    row_range itertuples() {
+        return row_range(this);
+    }
+
+    // iterate over all rows without copying them
+    const_row_range itertuples() const {
+        return const_row_range(this);
+    }
+
+    // copy count rows from the first one into out in row-major order, out holds count * column_num() items
+    void copy_rows(unsigned long long int first, unsigned long long int count, T *out) const {
+        if (first + count > static_cast<unsigned long long int>(length)) {
+            std::stringstream ssTemp;
+            ssTemp << first + count;
+            throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+        }
+        // tiles small enough to keep both the read columns and the written rows in cache
+        const unsigned long long int tile_rows = 64, tile_columns = 16;
+        unsigned long long int columns_num = matrix.size();
+        unsigned long long int step = column_array::block_size;
+        std::vector<const T *> columns(columns_num);
+        std::vector<std::vector<T>> buffers(columns_num);
+        // compressed columns are decoded one block of rows at a time
+        for (unsigned long long int start = 0; start < count; start += step) {
+            auto rows = std::min(step, count - start);
+            for (unsigned long long int j = 0; j < columns_num; ++j) {
+                const column_array &line = *matrix[j];
+                columns[j] = line.read(first + start, rows, buffers[j]);
+            }
+            T *target = out + start * columns_num;
+            for (unsigned long long int r = 0; r < rows; r += tile_rows) {
+                auto last_row = std::min(rows, r + tile_rows);
+                for (unsigned long long int c = 0; c < columns_num; c += tile_columns) {
+                    auto last_column = std::min(columns_num, c + tile_columns);
+                    for (auto j = c; j < last_column; ++j) {
+                        const T *source = columns[j];
+                        for (auto i = r; i < last_row; ++i) {
+                            target[i * columns_num + j] = source[i];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // build a value index on one column, replacing the existing one
+    /* Note: the index follows every change of the column. Rows appended since the last lookup are added to
+    it, any other write bumps the version of the column and the index is rebuilt by the next lookup. lookup and range
+    may be called from several threads at once, only the refresh of a stale index takes a lock */
+    bool create_index(const std::string &col, index_type type = hash) {
+        if (!contain(col))
+            return false;
+        index_entry &entry = value_index[col];
+        entry.type = type;
+        build_index(col, entry);
+        return true;
+    }
+
+    // drop the value index of one column
+    bool drop_index(const std::string &col) {
+        return value_index.erase(col) != 0;
+    }
+
+    // determine whether the column has a value index
+    bool has_index(const std::string &col) const {
+        return value_index.find(col) != value_index.end();
+    }
+
+    // get the rows whose value equals to the item, in ascending order, null matches no row
+    row_vector lookup(const std::string &col, const T &item) const {
+        if (column_array::is_null(item))
+            return row_vector();
+        auto entry = value_index.find(col);
+        if (entry == value_index.end())
+            return find_column(col).find(item, item);
+        refresh_index(col, entry->second);
+        row_vector rows;
+        if (entry->second.type == hash) {
+            auto bucket = entry->second.buckets.find(item);
+            if (bucket != entry->second.buckets.end())
+                rows = bucket->second;
+        } else {
+            value_less less(find_column(col));
+            const row_vector &order = entry->second.order;
+            rows.assign(std::lower_bound(order.begin(), order.end(), item, less),
+                        std::upper_bound(order.begin(), order.end(), item, less));
+        }
+        return rows;
+    }
+
+    // get the rows whose value lies in [low, high], ordered by value when the column has a sorted index
+    // null items and null bounds match no row
+    row_vector range(const std::string &col, const T &low, const T &high) const {
+        if (column_array::is_null(low) || column_array::is_null(high))
+            return row_vector();
+        auto entry = value_index.find(col);
+        if (entry == value_index.end() || entry->second.type != sorted)
+            return find_column(col).find(low, high);
+        refresh_index(col, entry->second);
+        value_less less(find_column(col));
+        const row_vector &order = entry->second.order;
+        auto first = std::lower_bound(order.begin(), order.end(), low, less);
+        auto last = std::upper_bound(first, order.end(), high, less);
+        return row_vector(first, last);
+    }
+
+    // compress every column with its smallest encoding
+    /* Note: a compressed column is decompressed by the first non-const access that needs plain items, such as a
+    write, iterators, data() or get_std_vector(). Const reads never decompress it: reads, find, the value indexes,
+    to_csv, to_matrix, cov and corr decode the items they need, and the const data() throws instead */
+    void compress() {
+        for (auto &item : matrix) {
+            item->compress();
+        }
+    }
+
+    // memory held by the items of all columns, in bytes
+    unsigned long long int memory_usage() const {
+        unsigned long long int total = 0;
+        for (const auto &item : matrix) {
+            total += item->memory_usage();
+        }
+        return total;
+    }
+
+    // copy all items into out as a dense matrix of row_num() x column_num() items
+    void to_matrix(T *out, matrix_layout layout = row_major) const {
+        if (layout == row_major) {
+            copy_rows(0, length, out);
+            return;
+        }
+        for (int j = 0; j < width; ++j) {
+            matrix[j]->decode(0, length, out + j * length);
+        }
+    }
+
+    // covariance of every pair of columns, both axes are ordered as the columns
+    dataframe<double> cov() const {
+        return pairwise(false);
+    }
+
+    // pearson correlation of every pair of columns, both axes are ordered as the columns
+    dataframe<double> corr() const {
+        return pairwise(true);
+    }
+
+    // export all columns as an arrow struct array whose buffers are the items of the columns
+    /* Note: the exported buffers keep the items alive until they are released. A column written after the
+    export copies its items first, so the exported buffers never change. A compressed column stays compressed
+    and exports a decoded copy of its items */
+    void export_arrow(ArrowSchema *schema, ArrowArray *array) const {
+        const char *format = arrow_format();
+        if (format == nullptr)
+            throw (std::invalid_argument("the type of items is not supported by arrow"));
+        std::unique_ptr<arrow_struct_schema> schema_data(new arrow_struct_schema(width));
+        std::unique_ptr<arrow_struct_array> array_data(new arrow_struct_array(width));
+        for (int i = 0; i < width; ++i) {
+            auto name = new std::string(column[i]);
+            schema_data->schemas[i] = {format, name->c_str(), nullptr, 0, 0, nullptr, nullptr,
+                                       release_column_schema, name};
+            auto items = new arrow_column_array(matrix[i]->share());
+            array_data->arrays[i] = {length, 0, 0, 2, 0, items->buffers, nullptr, nullptr,
+                                     release_column_array, items};
+        }
+        *schema = {"+s", "", nullptr, 0, width, schema_data->children.data(), nullptr,
+                   release_struct_schema, schema_data.release()};
+        *array = {length, 0, 0, 1, width, array_data->buffers, array_data->children.data(), nullptr,
+                  release_struct_array, array_data.release()};
+    }
+
+    // replace all data by an arrow struct array, its buffers are wrapped instead of copied
+    /* Note: the schema is released before returning, the array is released when no column refers to it.
+    Reads through a const frame, value() or the items returned by operator[] use the buffers in place, only
+    the first write to a column copies its items */
+    void import_arrow(ArrowSchema *schema, ArrowArray *array) {
+        const char *format = arrow_format();
+        if (format == nullptr)
+            throw (std::invalid_argument("the type of items is not supported by arrow"));
+        if (schema->release == nullptr || array->release == nullptr)
+            throw (std::invalid_argument("the arrow array is released"));
+        if (std::strcmp(schema->format, "+s") != 0 || schema->n_children != array->n_children ||
+            schema->dictionary != nullptr || array->dictionary != nullptr || array->offset < 0 || array->length < 0 ||
+            (array->null_count != 0 && array->buffers[0] != nullptr))
+            throw (std::invalid_argument("the arrow array is not a struct without null"));
+        string_vector names;
+        for (int64_t i = 0; i < schema->n_children; ++i) {
+            const ArrowSchema *type = schema->children[i];
+            const ArrowArray *child = array->children[i];
+            // plain primitive children only, holding every row of the struct
+            if (std::strcmp(type->format, format) != 0 || type->dictionary != nullptr || type->n_children != 0 ||
+                child->dictionary != nullptr || child->n_children != 0 || child->n_buffers != 2 ||
+                child->offset < 0 || child->length < array->offset + array->length ||
+                (child->buffers[1] == nullptr && array->length > 0) ||
+                (child->null_count != 0 && child->buffers[0] != nullptr))
+                throw (std::invalid_argument("the arrow child \'" + std::to_string(i) + "\' is not supported!"));
+            const char *name = schema->children[i]->name;
+            names.emplace_back(name != nullptr ? name : std::to_string(i));
+        }
+        // move the array into a holder shared by the columns
+        std::shared_ptr<ArrowArray> owner(new ArrowArray(*array), [](ArrowArray *item) {
+            if (item->release != nullptr)
+                item->release(item);
+            delete item;
+        });
+        array->release = nullptr;
+        clear();
+        column_paste(names);
+        for (int i = 0; i < width; ++i) {
+            const ArrowArray *child = owner->children[i];
+            auto items = static_cast<const T *>(child->buffers[1]) + owner->offset + child->offset;
+            delete matrix[i];
+            matrix[i] = new column_array(std::shared_ptr<const T>(owner, items), owner->length);
+        }
+        length = owner->length;
+        schema->release(schema);
+    }
+
 private:
+    // private data of an exported struct schema, the children own their names
+    struct arrow_struct_schema {
+        std::vector<ArrowSchema> schemas;
+        std::vector<ArrowSchema *> children;
+
+        explicit arrow_struct_schema(long long int n) : schemas(n), children(n) {
+            for (long long int i = 0; i < n; ++i) {
+                children[i] = &schemas[i];
+            }
+        }
+    };
+
+    // private data of an exported struct array
+    struct arrow_struct_array {
+        std::vector<ArrowArray> arrays;
+        std::vector<ArrowArray *> children;
+        const void *buffers[1] = {nullptr};
+
+        explicit arrow_struct_array(long long int n) : arrays(n), children(n) {
+            for (long long int i = 0; i < n; ++i) {
+                children[i] = &arrays[i];
+            }
+        }
+    };
+
+    // private data of an exported column, it keeps the items alive
+    struct arrow_column_array {
+        std::shared_ptr<const T> items;
+        const void *buffers[2] = {nullptr, nullptr};
+        int64_t empty = 0;
+
+        explicit arrow_column_array(std::shared_ptr<const T> _items) : items(std::move(_items)) {
+            buffers[1] = items ? static_cast<const void *>(items.get()) : &empty;
+        }
+    };
+
+    static void release_struct_schema(ArrowSchema *schema) {
+        auto data = static_cast<arrow_struct_schema *>(schema->private_data);
+        for (auto &child : data->schemas) {
+            if (child.release != nullptr)
+                child.release(&child);
+        }
+        delete data;
+        schema->release = nullptr;
+    }
+
+    static void release_column_schema(ArrowSchema *schema) {
+        delete static_cast<std::string *>(schema->private_data);
+        schema->release = nullptr;
+    }
+
+    static void release_struct_array(ArrowArray *array) {
+        auto data = static_cast<arrow_struct_array *>(array->private_data);
+        for (auto &child : data->arrays) {
+            if (child.release != nullptr)
+                child.release(&child);
+        }
+        delete data;
+        array->release = nullptr;
+    }
+
+    static void release_column_array(ArrowArray *array) {
+        delete static_cast<arrow_column_array *>(array->private_data);
+        array->release = nullptr;
+    }
+
+    // covariance or correlation of all pairs of columns, nulls propagate into the result
+    dataframe<double> pairwise(bool normalize) const {
+        auto n = static_cast<unsigned long long int>(length);
+        auto k = static_cast<unsigned long long int>(width);
+        // items minus the mean of their column, column-major
+        std::vector<double> centered(n * k);
+        std::vector<T> buffer;
+        for (unsigned long long int j = 0; j < k; ++j) {
+            const column_array &line = *matrix[j];
+            const T *items = line.read(0, n, buffer);
+            double *target = centered.data() + j * n;
+            double mean = 0;
+            for (unsigned long long int i = 0; i < n; ++i) {
+                mean += static_cast<double>(items[i]);
+            }
+            mean /= static_cast<double>(n);
+            for (unsigned long long int i = 0; i < n; ++i) {
+                target[i] = static_cast<double>(items[i]) - mean;
+            }
+        }
+
+        // the upper triangle is split into tiles of block x block columns, each walked in chunks of rows
+        // so that the columns of a tile stay in cache, and the tiles are shared out among the threads
+        const unsigned long long int block = 8, chunk = 2048;
+        auto blocks = (k + block - 1) / block;
+        std::vector<std::pair<unsigned long long int, unsigned long long int>> tiles;
+        for (unsigned long long int a = 0; a < blocks; ++a) {
+            for (auto b = a; b < blocks; ++b) {
+                tiles.emplace_back(a * block, b * block);
+            }
+        }
+        std::vector<double> products(k * k, 0);
+        std::atomic<unsigned long long int> next(0);
+        auto worker = [&]() {
+            for (auto t = next++; t < tiles.size(); t = next++) {
+                auto last_a = std::min(k, tiles[t].first + block);
+                auto last_b = std::min(k, tiles[t].second + block);
+                for (unsigned long long int r = 0; r < n; r += chunk) {
+                    auto rows = std::min(chunk, n - r);
+                    for (auto a = tiles[t].first; a < last_a; ++a) {
+                        for (auto b = std::max(a, tiles[t].second); b < last_b; ++b) {
+                            const double *x = centered.data() + a * n + r, *y = centered.data() + b * n + r;
+                            products[a * k + b] += dot(x, y, rows);
+                        }
+                    }
+                }
+            }
+        };
+        // small matrices are not worth a thread
+        unsigned long long int threads = std::max(1U, std::thread::hardware_concurrency());
+        threads = std::min<unsigned long long int>(threads, tiles.size());
+        threads = std::min<unsigned long long int>(threads, std::max(1ULL, n * k * k >> 22));
+        std::vector<std::thread> pool;
+        for (unsigned long long int i = 1; i < threads; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto &item : pool) {
+            item.join();
+        }
+
+        dataframe<double> result(column);
+        std::vector<double> line(k);
+        for (unsigned long long int a = 0; a < k; ++a) {
+            for (unsigned long long int b = 0; b < k; ++b) {
+                double value = n < 2 ? std::numeric_limits<double>::quiet_NaN() :
+                               products[std::min(a, b) * k + std::max(a, b)] / static_cast<double>(n - 1);
+                if (normalize)
+                    value *= (n - 1) / std::sqrt(products[a * k + a] * products[b * k + b]);
+                line[b] = value;
+            }
+            result.append(line);
+        }
+        return result;
+    }
+
+    // dot product kept in four independent sums, so the compiler can put them into one SIMD register
+    static double dot(const double *x, const double *y, unsigned long long int n) {
+        double sums[4] = {0, 0, 0, 0};
+        unsigned long long int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            sums[0] += x[i] * y[i];
+            sums[1] += x[i + 1] * y[i + 1];
+            sums[2] += x[i + 2] * y[i + 2];
+            sums[3] += x[i + 3] * y[i + 3];
+        }
+        for (; i < n; ++i) {
+            sums[0] += x[i] * y[i];
+        }
+        return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    }
+
+    // format string of the items in arrow, nullptr when arrow has no such type
+    static const char *arrow_format() {
+        if (std::is_floating_point<T>::value)
+            return sizeof(T) == 4 ? "f" : sizeof(T) == 8 ? "g" : nullptr;
+        if (!std::is_integral<T>::value || std::is_same<T, bool>::value)
+            return nullptr;
+        bool is_signed = std::is_signed<T>::value;
+        switch (sizeof(T)) {
+            case 1:
+                return is_signed ? "c" : "C";
+            case 2:
+                return is_signed ? "s" : "S";
+            case 4:
+                return is_signed ? "i" : "I";
+            case 8:
+                return is_signed ? "l" : "L";
+            default:
+                return nullptr;
+        }
+    }
+
+    // value index of one column, null items are left out
+    /* Note: version and rows are published after the buckets and the order, a lookup finding both up to date
+    reads the index without locking */
+    struct index_entry {
+        index_type type = hash;
+        std::atomic<unsigned long long int> version{0}; // version of the column the index was built from
+        std::atomic<unsigned long long int> rows{0};    // rows already in the index
+        std::unordered_map<T, row_vector> buckets;
+        row_vector order;
+
+        index_entry() = default;
+
+        index_entry(const index_entry &entry) :
+                type(entry.type),
+                version(entry.version.load()),
+                rows(entry.rows.load()),
+                buckets(entry.buckets),
+                order(entry.order) {}
+
+        index_entry &operator=(const index_entry &entry) {
+            type = entry.type;
+            version = entry.version.load();
+            rows = entry.rows.load();
+            buckets = entry.buckets;
+            order = entry.order;
+            return *this;
+        }
+    };
+
+    // order row numbers by the value they point to, read in place or from the compressed column
+    struct value_less {
+        const column_array *line;
+        const T *values;
+
+        explicit value_less(const column_array &_line, const T *_values = nullptr) :
+                line(&_line),
+                values(_values != nullptr || _line.get_encoding() != column_array::plain ? _values : _line.data()) {}
+
+        T at(unsigned long long int i) const {
+            return values != nullptr ? values[i] : line->value(i);
+        }
+
+        bool operator()(unsigned long long int a, unsigned long long int b) const {
+            return at(a) < at(b);
+        }
+
+        bool operator()(unsigned long long int a, const T &item) const {
+            return at(a) < item;
+        }
+
+        bool operator()(const T &item, unsigned long long int b) const {
+            return item < at(b);
+        }
+    };
+
+    //get one column data from column str, without inserting it
+    const column_array &find_column(const std::string &col) const {
+        auto item = index.find(col);
+        if (item != index.end())
+            return *(matrix[item->second]);
+        throw (std::out_of_range("the column \'" + col + "\' is not found!"));
+    }
+
+    // bring the value index of one column up to date with its items
+    void refresh_index(const std::string &col, index_entry &entry) const {
+        const column_array &line = find_column(col);
+        if (entry.version == line.get_version() && entry.rows == line.size())
+            return;
+        std::lock_guard<std::mutex> lock(index_mutex);
+        if (entry.version != line.get_version() || entry.rows > line.size())
+            build_index(col, entry);
+        else if (entry.rows < line.size())
+            extend_index(line, entry);
+    }
+
+    // copy all value indexes, none of them is refreshed meanwhile
+    std::unordered_map<std::string, index_entry> copy_index() const {
+        std::lock_guard<std::mutex> lock(index_mutex);
+        return value_index;
+    }
+
+    // rebuild the value index of one column from scratch
+    void build_index(const std::string &col, index_entry &entry) const {
+        const column_array &line = find_column(col);
+        entry.buckets.clear();
+        entry.order.clear();
+        entry.rows = 0;
+        entry.version = line.get_version();
+        extend_index(line, entry);
+    }
+
+    // add the rows appended to the column since the last update into its value index
+    /* Note: a compressed column stays compressed, its items are decoded into a buffer dropped afterwards */
+    void extend_index(const column_array &line, index_entry &entry) const {
+        unsigned long long int first = entry.rows;
+        if (entry.type == hash) {
+            std::vector<T> buffer;
+            const T *values = line.read(first, line.size() - first, buffer);
+            for (auto i = first; i < line.size(); ++i) {
+                if (!column_array::is_null(values[i - first]))
+                    entry.buckets[values[i - first]].emplace_back(i);
+            }
+        } else if (first == 0 && line.sorted()) {
+            for (auto i = first; i < line.size(); ++i) {
+                entry.order.emplace_back(i);
+            }
+        } else {
+            std::vector<T> buffer;
+            if (line.get_encoding() != column_array::plain) {
+                buffer.resize(line.size());
+                line.decode(0, buffer.size(), buffer.data());
+            }
+            value_less less(line, buffer.empty() ? nullptr : buffer.data());
+            auto middle = entry.order.size();
+            for (auto i = first; i < line.size(); ++i) {
+                if (!column_array::is_null(less.at(i)))
+                    entry.order.emplace_back(i);
+            }
+            std::stable_sort(entry.order.begin() + middle, entry.order.end(), less);
+            std::inplace_merge(entry.order.begin(), entry.order.begin() + middle, entry.order.end(), less);
+        }
+        entry.rows = line.size();
+    }
+
+    // write all rows as text, every column is decoded once per block of rows
+    void write_rows(std::ostream &cout, char delimiter, bool trailing) const {
+        std::vector<std::vector<T>> items(matrix.size());
+        unsigned long long int rows = static_cast<unsigned long long int>(length);
+        unsigned long long int step = column_array::block_size;
+        for (unsigned long long int first = 0; first < rows; first += step) {
+            auto count = std::min(step, rows - first);
+            for (unsigned long long int j = 0; j < matrix.size(); ++j) {
+                items[j].resize(count);
+                matrix[j]->decode(first, count, items[j].data());
+            }
+            for (unsigned long long int i = 0; i < count; ++i) {
+                for (unsigned long long int j = 0; j < matrix.size(); ++j) {
+                    cout << items[j][i];
+                    if (trailing || j + 1 < matrix.size())
+                        cout << delimiter;
+                }
+                cout << '\n';
+            }
+        }
+    }
+
     // clear all data, generate an empty dataframe
     void clear() {
         length = 0;
@@ -661,6 +2034,7 @@ private:
         matrix.clear();
         column.clear();
         index.clear();
+        value_index.clear();
     }
 
     //init the column
@@ -669,6 +2043,7 @@ private:
             width = _column.size();
             column.clear();
             index.clear();
+            value_index.clear();
             matrix.clear();
             for (const auto &item : _column) {
                 column.emplace_back(item);
@@ -705,13 +2080,9 @@ private:
     }
 
     //get one row data from index of row
-    row_array get_row(int i) {
+    row_ref get_row(int i) {
         if (i < length) {
-            row_array row_array;
-            for (auto &item : matrix) {
-                row_array.push_back(&((*item)[i]));
-            }
-            return std::move(row_array);
+            return row_ref(this, i);
         } else {
             std::stringstream ssTemp;
             ssTemp << i;
@@ -720,13 +2091,9 @@ private:
     }
 
     //get one row data from index of row
-    const row_array &get_row(int i) const {
+    const_row_ref get_row(int i) const {
         if (i < length) {
-            row_array row_array;
-            for (auto &item : matrix) {
-                row_array.push_back(&((*item)[i]));
-            }
-            return std::move(row_array);
+            return const_row_ref(this, i);
         } else {
             std::stringstream ssTemp;
             ssTemp << i;
@@ -774,6 +2141,8 @@ private:
     long long int width;
     long long int length;
     std::unordered_map<std::string, unsigned long long int> index;
+    mutable std::unordered_map<std::string, index_entry> value_index;
+    mutable std::mutex index_mutex; // serializes the refreshes of value_index, up to date indexes are read freely
 };
 
 #endif // DATAFRAME_H